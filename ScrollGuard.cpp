@@ -7,13 +7,22 @@
 //   cl /std:c++17 /EHsc /W4 /DUNICODE /D_UNICODE ScrollGuard.cpp user32.lib kernel32.lib psapi.lib
 // Run:
 //   ScrollGuard.exe
+// Upgrade a running instance in place (takes over its target and counters):
+//   ScrollGuard.exe --upgrade
+// Show where blocked/passed wheel events landed (from another console):
+//   ScrollGuard.exe --heatmap
 // Exit:
 //   Press Ctrl+C in the console.
+//
+// Tests: tests/ScrollGuardTests.cpp defines SCROLLGUARD_NO_WMAIN and #includes this
+// file against a simulated desktop (tests/win32_shim), so everything above the
+// console front end runs on Linux too. See that file for the build line.
 
 #define WIN32_LEAN_AND_MEAN
 #define NOMINMAX // avoid Windows macros clobbering std::numeric_limits::max
 #include <windows.h>
 #include <psapi.h>
+#include <winternl.h> // NtQuerySystemInformation types for the exit stats
 
 #include <vector>
 #include <string>
@@ -29,10 +38,56 @@ struct AppEntry {
   std::wstring windowTitle;
 };
 
+// Wakeup accounting for the main thread, which owns both hooks and the message
+// loop. The mouse hook is only installed while the target is foreground, so
+// while it isn't, the only thing that can wake us is a foreground change.
+struct WakeupStats {
+  unsigned long long foregroundChanges = 0; // EVENT_SYSTEM_FOREGROUND callbacks
+  unsigned long long hookCalls = 0;         // low-level mouse hook callbacks (target foreground only)
+  unsigned long long wheelEvents = 0;       // hook callbacks that carried a wheel message
+  unsigned long long blocked = 0;           // wheel events we swallowed
+  unsigned long long loopWakeups = 0;       // messages returned by GetMessageW; 0 while idle
+};
+
+// Coarse per-monitor grid of wheel events, fixed size so the hook only ever
+// does a bounds check and one increment
+static const int kHeatMaxMonitors = 8;
+static const int kHeatCols = 16;
+static const int kHeatRows = 9;
+
+struct MonitorHeat {
+  RECT rect;                                  // monitor bounds in physical screen coords
+  DWORD displayNumber;                        // n from \\.\DISPLAYn, as numbered by Windows
+  BOOL primary;
+  unsigned long blocked[kHeatRows][kHeatCols];
+  unsigned long passed[kHeatRows][kHeatCols];
+};
+
+struct HeatmapStats {
+  DWORD monitorCount;                         // monitor layout captured at startup
+  MonitorHeat monitors[kHeatMaxMonitors];
+};
+
+// Counters that outlive one process: they sit in the section shared with other
+// instances and are carried across --upgrade
+struct SessionStats {
+  unsigned long long wheelEvents;
+  unsigned long long blocked;
+  HeatmapStats heat;
+};
+
 // Globals for the hook
-static HHOOK g_mouseHook = nullptr;
+static HHOOK g_mouseHook = nullptr;       // Only installed while the target is foreground
+static HWINEVENTHOOK g_foregroundHook = nullptr;
 static DWORD g_targetPid = 0;             // The process we protect when in foreground
+static WakeupStats g_stats;               // This process only
+static SessionStats g_localSession;       // used until/unless the shared section is mapped
+static SessionStats* g_session = &g_localSession;
+static DWORD g_mainThreadId = 0;          // Thread that owns the hooks and the message loop
 static volatile bool g_running = true;
+// Owner PID in the shared section. During a handoff both instances' hooks see the
+// same events; only the owner writes g_session, so each event is counted once.
+static const volatile DWORD* g_sessionOwner = nullptr;
 
 // Get base process name from PID
 static std::wstring GetProcessNameFromPid(DWORD pid) {
@@ -119,40 +174,109 @@ static DWORD PidFromPoint(POINT pt) {
   return pid;
 }
 
+// Bump the heatmap cell under pt (points off every known monitor are dropped)
+static void RecordHeat(POINT pt, bool blocked) {
+  HeatmapStats& heat = g_session->heat;
+  for (DWORD m = 0; m < heat.monitorCount; ++m) {
+    MonitorHeat& mh = heat.monitors[m];
+    const RECT& r = mh.rect;
+    if (pt.x < r.left || pt.x >= r.right || pt.y < r.top || pt.y >= r.bottom) continue;
+    LONG col = (pt.x - r.left) * kHeatCols / (r.right - r.left);
+    LONG row = (pt.y - r.top) * kHeatRows / (r.bottom - r.top);
+    ++(blocked ? mh.blocked : mh.passed)[row][col];
+    return;
+  }
+}
+
+// Whether this instance writes the session counters (always, unless a newer
+// instance has taken over the shared section)
+static bool OwnsSession() {
+  return !g_sessionOwner || *g_sessionOwner == GetCurrentProcessId();
+}
+
 // Low-level mouse hook: swallow wheel events when target app is focused and mouse is NOT over it
 static LRESULT CALLBACK LowLevelMouseProc(int nCode, WPARAM wParam, LPARAM lParam) {
+  ++g_stats.hookCalls;
   if (nCode == HC_ACTION && g_targetPid != 0) {
     if (wParam == WM_MOUSEWHEEL || wParam == WM_MOUSEHWHEEL) {
+      ++g_stats.wheelEvents;
+      const MSLLHOOKSTRUCT* info = reinterpret_cast<const MSLLHOOKSTRUCT*>(lParam);
+      POINT pt = info->pt; // screen coords
       HWND fg = GetForegroundWindow();
       DWORD fgPid = 0;
       if (fg) GetWindowThreadProcessId(fg, &fgPid);
 
-      if (fgPid == g_targetPid) {
-        const MSLLHOOKSTRUCT* info = reinterpret_cast<const MSLLHOOKSTRUCT*>(lParam);
-        POINT pt = info->pt; // screen coords
-        DWORD underPid = PidFromPoint(pt);
-        if (underPid != g_targetPid) {
-          return 1; // block event globally for other apps
-        }
+      bool block = fgPid == g_targetPid && PidFromPoint(pt) != g_targetPid;
+      if (block) ++g_stats.blocked;
+      // The hook only exists while the target is foreground (UpdateMouseHook), so
+      // session totals and "passed" cells cover focused time only, not all scrolling
+      if (OwnsSession()) {
+        ++g_session->wheelEvents;
+        if (block) ++g_session->blocked;
+        RecordHeat(pt, block);
       }
+      if (block) return 1; // block event globally for other apps
     }
   }
   return CallNextHookEx(g_mouseHook, nCode, wParam, lParam);
 }
 
-// Clean shutdown on Ctrl+C
-static BOOL WINAPI ConsoleCtrlHandler(DWORD type) {
-  if (type == CTRL_C_EVENT || type == CTRL_BREAK_EVENT || type == CTRL_CLOSE_EVENT) {
-    g_running = false;
-    if (g_mouseHook) { UnhookWindowsHookEx(g_mouseHook); g_mouseHook = nullptr; }
-    return TRUE;
+// Install the mouse hook while the target owns the foreground window and remove it
+// otherwise, so mouse movement costs nothing while you're in other apps
+static bool UpdateMouseHook(HWND fg) {
+  DWORD fgPid = 0;
+  if (fg) GetWindowThreadProcessId(fg, &fgPid);
+  if (fgPid == g_targetPid && g_targetPid != 0) {
+    if (!g_mouseHook) g_mouseHook = SetWindowsHookExW(WH_MOUSE_LL, LowLevelMouseProc, nullptr, 0);
+    return g_mouseHook != nullptr;
   }
-  return FALSE;
+  if (g_mouseHook) { UnhookWindowsHookEx(g_mouseHook); g_mouseHook = nullptr; }
+  return true;
 }
 
-static void FlushInputLine() {
-  // Clear through newline to allow subsequent getline()
-  std::wcin.ignore(std::numeric_limits<std::streamsize>::max(), L'\n');
+static void CALLBACK ForegroundEventProc(HWINEVENTHOOK, DWORD, HWND hwnd, LONG, LONG, DWORD, DWORD) {
+  ++g_stats.foregroundChanges;
+  if (!UpdateMouseHook(hwnd)) {
+    std::wcerr << L"Failed to install mouse hook; scrolling is not guarded." << std::endl;
+  }
+}
+
+// Follow the foreground window from the calling thread, and hook the mouse right
+// away if the target already has it. That thread must then run RunMessageLoop.
+static bool BeginGuarding() {
+  g_mainThreadId = GetCurrentThreadId();
+  g_foregroundHook = SetWinEventHook(EVENT_SYSTEM_FOREGROUND, EVENT_SYSTEM_FOREGROUND, nullptr,
+                                     ForegroundEventProc, 0, 0,
+                                     WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS);
+  return g_foregroundHook && UpdateMouseHook(GetForegroundWindow());
+}
+
+static void EndGuarding() {
+  if (g_mouseHook) { UnhookWindowsHookEx(g_mouseHook); g_mouseHook = nullptr; }
+  if (g_foregroundHook) { UnhookWinEvent(g_foregroundHook); g_foregroundHook = nullptr; }
+}
+
+// Keep the hooks alive until WM_QUIT. Hook and WinEvent callbacks are dispatched
+// inside GetMessageW without returning, so an idle guard never counts a wakeup;
+// anything that does (a timer, a stray PostMessage) shows up in loopWakeups.
+static void RunMessageLoop() {
+  MSG msg;
+  while (g_running && GetMessageW(&msg, nullptr, 0, 0) > 0) {
+    ++g_stats.loopWakeups;
+    TranslateMessage(&msg);
+    DispatchMessageW(&msg);
+  }
+}
+
+// One heatmap row as shade characters scaled against the grid's hottest cell
+static std::wstring HeatRow(const unsigned long (&row)[kHeatCols], unsigned long hottest) {
+  static const wchar_t kShades[] = L" .:-=+*#%@";
+  const unsigned long levels = sizeof(kShades) / sizeof(kShades[0]) - 2; // minus blank and NUL
+  std::wstring out;
+  for (unsigned long v : row) {
+    out += (v == 0 || hottest == 0) ? L' ' : kShades[1 + (v * levels - 1) / hottest]; // hottest => '@'
+  }
+  return out;
 }
 
 // Helper: hover-select PID under the mouse
@@ -168,11 +292,355 @@ static DWORD HoverSelectPid() {
   }
   return pid;
 }
-int wmain() {
-  std::wcout << L"ScrollGuard - block inactive-window scrolling when your chosen app is focused\n";
-  std::wcout << L"--------------------------------------------------------------------------------\n\n";
 
-  // 1) Enumerate candidates and let the user pick (or hover-select fallback)
+// ---- Shared state and the --upgrade handoff ----
+
+static volatile bool g_handedOff = false; // a newer instance took over (see --upgrade)
+
+// State shared with other ScrollGuard instances so a new version can take over
+// without a gap: it reads the policy + counters, hooks, then tells us to unhook.
+// The header never changes shape, so any build can tell who owns the section
+// even when it can't understand the payload.
+struct SharedHeader {
+  volatile LONG magic;      // kSharedMagic once the header is complete, 0 before
+  DWORD version;            // kSharedVersion of the build that created the section
+  DWORD size;               // sizeof(SharedState) of that build
+  volatile DWORD ownerPid;  // instance currently guarding (0 = none)
+};
+
+// Versioned payload; bump kSharedVersion whenever anything below the header changes
+struct SharedState {
+  SharedHeader header;
+  DWORD targetPid;          // policy handed to the next instance
+  SessionStats session;     // counters + heatmap carried across upgrades
+};
+static const LONG kSharedMagic = 0x44475353; // "SSGD"
+static const DWORD kSharedVersion = 2;    // 2: monitors carry their display number
+static const wchar_t* kSharedStateName = L"Local\\ScrollGuard.State";
+static const int kHeaderWaitMs = 1000;    // how long a reader waits for a creator to finish
+static const DWORD kHandoffTimeoutMs = 5000; // how long a successor waits for us to exit
+static HANDLE g_sharedMap = nullptr;
+static SharedState* g_shared = nullptr;
+static HANDLE g_handoffEvent = nullptr;   // signalled by a successor once its hook is live
+
+enum class SharedStatus {
+  Ok,           // g_shared is mapped and matches this build
+  Missing,      // no instance is running
+  Starting,     // the creator hasn't finished writing the header yet
+  Incompatible, // another build's section (older/newer layout, or no header at all)
+  Failed,       // exists but can't be opened/mapped (e.g. different privilege level)
+};
+
+// Map an existing section and check its header before trusting any field.
+// foreignOwner is set when the section is readable enough to name its owner.
+static SharedStatus MapExistingSharedState(HANDLE map, DWORD& foreignOwner) {
+  void* view = MapViewOfFile(map, FILE_MAP_ALL_ACCESS, 0, 0, 0); // whatever size its creator chose
+  if (!view) { CloseHandle(map); return SharedStatus::Failed; }
+  MEMORY_BASIC_INFORMATION mbi{};
+  SIZE_T mapped = VirtualQuery(view, &mbi, sizeof(mbi)) ? mbi.RegionSize : 0;
+  const SharedHeader* header = static_cast<const SharedHeader*>(view);
+
+  SharedStatus status = SharedStatus::Incompatible;
+  if (mapped >= sizeof(SharedHeader)) {
+    // A new section is zero-filled until its creator publishes magic; give it a moment
+    for (int waited = 0; header->magic == 0 && waited < kHeaderWaitMs; waited += 10) Sleep(10);
+    LONG magic = header->magic;
+    MemoryBarrier(); // pairs with the InterlockedExchange in OpenSharedState
+    if (magic == 0) {
+      status = SharedStatus::Starting;
+    } else if (magic == kSharedMagic) {
+      foreignOwner = header->ownerPid;
+      if (header->version == kSharedVersion && header->size == sizeof(SharedState) &&
+          mapped >= sizeof(SharedState)) {
+        status = SharedStatus::Ok;
+      }
+    }
+  }
+  if (status != SharedStatus::Ok) {
+    UnmapViewOfFile(view);
+    CloseHandle(map);
+    return status;
+  }
+  g_sharedMap = map;
+  g_shared = static_cast<SharedState*>(view);
+  return SharedStatus::Ok;
+}
+
+// Open the section shared by all ScrollGuard instances, creating it if allowed
+static SharedStatus OpenSharedState(bool create, DWORD& foreignOwner) {
+  foreignOwner = 0;
+  HANDLE map = OpenFileMappingW(FILE_MAP_ALL_ACCESS, FALSE, kSharedStateName);
+  if (map) return MapExistingSharedState(map, foreignOwner);
+  if (GetLastError() != ERROR_FILE_NOT_FOUND) return SharedStatus::Failed;
+  if (!create) return SharedStatus::Missing;
+
+  map = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                           0, sizeof(SharedState), kSharedStateName);
+  if (!map) return SharedStatus::Failed;
+  if (GetLastError() == ERROR_ALREADY_EXISTS) return MapExistingSharedState(map, foreignOwner);
+
+  void* view = MapViewOfFile(map, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(SharedState));
+  if (!view) { CloseHandle(map); return SharedStatus::Failed; }
+  g_sharedMap = map;
+  g_shared = static_cast<SharedState*>(view); // zero-filled
+  g_shared->header.version = kSharedVersion;
+  g_shared->header.size = sizeof(SharedState);
+  // Magic last, with a full barrier, so a reader that sees it also sees version and size
+  InterlockedExchange(&g_shared->header.magic, kSharedMagic);
+  return SharedStatus::Ok;
+}
+
+static bool IsProcessAlive(DWORD pid) {
+  HANDLE hProc = OpenProcess(SYNCHRONIZE, FALSE, pid);
+  if (!hProc) return false;
+  bool alive = WaitForSingleObject(hProc, 0) == WAIT_TIMEOUT;
+  CloseHandle(hProc);
+  return alive;
+}
+
+// Each instance listens on its own event so a successor never wakes itself
+static std::wstring HandoffEventName(DWORD pid) {
+  return L"Local\\ScrollGuard.Handoff." + std::to_wstring(pid);
+}
+
+// Blocks (no polling) until a newer instance has its hook in place, then quits
+static DWORD WINAPI HandoffWaiter(LPVOID param) {
+  HANDLE ev = static_cast<HANDLE>(param);
+  if (WaitForSingleObject(ev, INFINITE) == WAIT_OBJECT_0) {
+    g_handedOff = true;
+    g_running = false;
+    PostThreadMessageW(g_mainThreadId, WM_QUIT, 0, 0);
+  }
+  return 0;
+}
+
+// The instance currently guarding, if it's another process that is still alive (else 0)
+static DWORD LiveOwner() {
+  DWORD owner = g_shared->header.ownerPid;
+  if (owner == GetCurrentProcessId() || (owner != 0 && !IsProcessAlive(owner))) return 0;
+  return owner;
+}
+
+// Count into the shared section from now on (only while we are its published owner)
+static void AttachSession() {
+  g_session = &g_shared->session;
+  g_sessionOwner = &g_shared->header.ownerPid;
+}
+
+// Listen for a successor's signal. Must succeed before we publish ownership:
+// a successor that can't reach us would leave both instances hooked for good.
+static bool StartHandoffListener() {
+  g_handoffEvent = CreateEventW(nullptr, FALSE, FALSE, HandoffEventName(GetCurrentProcessId()).c_str());
+  if (!g_handoffEvent) return false;
+  HANDLE waiter = CreateThread(nullptr, 0, HandoffWaiter, g_handoffEvent, 0, nullptr);
+  if (!waiter) {
+    CloseHandle(g_handoffEvent);
+    g_handoffEvent = nullptr;
+    return false;
+  }
+  CloseHandle(waiter);
+  return true;
+}
+
+// Become the instance a successor hands off from, and the one counting the session
+static void PublishOwnership() {
+  g_shared->targetPid = g_targetPid;
+  InterlockedExchange(reinterpret_cast<volatile LONG*>(&g_shared->header.ownerPid),
+                      static_cast<LONG>(GetCurrentProcessId()));
+}
+
+// Clear ownership on the way out, unless a successor has already taken it
+static void ReleaseOwnership() {
+  InterlockedCompareExchange(reinterpret_cast<volatile LONG*>(&g_shared->header.ownerPid),
+                             0, static_cast<LONG>(GetCurrentProcessId()));
+}
+
+enum class HandoffResult {
+  Done,         // the previous owner unhooked and exited
+  Unconfirmed,  // it was signalled, but we couldn't see it exit in time
+  NotSignalled, // it couldn't be reached; ownership went back to it
+};
+
+// With our hook live and ownership published, tell prevOwner to unhook and wait
+// for its process to exit, so "upgraded" means the old hook is really gone
+static HandoffResult TakeOverFrom(DWORD prevOwner, DWORD timeoutMs) {
+  // Open the process before signalling so its PID can't be reused under us
+  HANDLE prevProc = OpenProcess(SYNCHRONIZE, FALSE, prevOwner);
+  HANDLE prevEvent = OpenEventW(EVENT_MODIFY_STATE, FALSE, HandoffEventName(prevOwner).c_str());
+  bool signalled = prevEvent && SetEvent(prevEvent);
+  if (prevEvent) CloseHandle(prevEvent);
+  if (!signalled) {
+    if (prevProc) CloseHandle(prevProc);
+    InterlockedCompareExchange(reinterpret_cast<volatile LONG*>(&g_shared->header.ownerPid),
+                               static_cast<LONG>(prevOwner), static_cast<LONG>(GetCurrentProcessId()));
+    return HandoffResult::NotSignalled;
+  }
+  bool exited = prevProc && WaitForSingleObject(prevProc, timeoutMs) == WAIT_OBJECT_0;
+  if (prevProc) CloseHandle(prevProc);
+  return exited ? HandoffResult::Done : HandoffResult::Unconfirmed;
+}
+
+#ifndef SCROLLGUARD_NO_WMAIN
+// ---- Console front end (left out when SCROLLGUARD_NO_WMAIN is defined) ----
+
+static BOOL CALLBACK EnumMonitorsProc(HMONITOR hMon, HDC, LPRECT rect, LPARAM lParam) {
+  HeatmapStats& heat = *(HeatmapStats*)lParam;
+  if (heat.monitorCount >= (DWORD)kHeatMaxMonitors) return FALSE;
+  if (rect->right <= rect->left || rect->bottom <= rect->top) return TRUE;
+  MonitorHeat& mh = heat.monitors[heat.monitorCount];
+  mh.rect = *rect;
+  MONITORINFOEXW info{};
+  info.cbSize = sizeof(info);
+  if (GetMonitorInfoW(hMon, &info)) {
+    // "\\.\DISPLAY2" -> 2, the number Windows shows in Display settings
+    const wchar_t* digits = wcspbrk(info.szDevice, L"0123456789");
+    mh.displayNumber = digits ? static_cast<DWORD>(wcstoul(digits, nullptr, 10)) : 0;
+    mh.primary = (info.dwFlags & MONITORINFOF_PRIMARY) != 0;
+  }
+  if (mh.displayNumber == 0) mh.displayNumber = heat.monitorCount + 1;
+  ++heat.monitorCount;
+  return TRUE;
+}
+
+// Capture the monitor layout for the heatmap, ordered like Windows numbers them.
+// Needs per-monitor DPI awareness so the rectangles are in the same physical
+// coordinates as the hook's MSLLHOOKSTRUCT::pt.
+static void CaptureMonitors(HeatmapStats& heat) {
+  heat.monitorCount = 0;
+  EnumDisplayMonitors(nullptr, nullptr, EnumMonitorsProc, (LPARAM)&heat);
+  std::sort(heat.monitors, heat.monitors + heat.monitorCount, [](const MonitorHeat& a, const MonitorHeat& b){
+    return a.displayNumber < b.displayNumber;
+  });
+}
+
+// Clean shutdown on Ctrl+C. The handler runs on its own thread, so wake the
+// message loop with WM_QUIT instead of polling g_running; the main thread unhooks.
+static BOOL WINAPI ConsoleCtrlHandler(DWORD type) {
+  if (type == CTRL_C_EVENT || type == CTRL_BREAK_EVENT || type == CTRL_CLOSE_EVENT) {
+    g_running = false;
+    PostThreadMessageW(g_mainThreadId, WM_QUIT, 0, 0);
+    return TRUE;
+  }
+  return FALSE;
+}
+
+static unsigned long HottestCell(const unsigned long (&grid)[kHeatRows][kHeatCols], unsigned long& total) {
+  unsigned long hottest = 0;
+  for (const auto& row : grid) {
+    for (unsigned long v : row) { total += v; hottest = std::max(hottest, v); }
+  }
+  return hottest;
+}
+
+// --heatmap: render the running instance's grids as text
+static int PrintHeatmap() {
+  DWORD foreignOwner = 0;
+  SharedStatus status = OpenSharedState(false, foreignOwner);
+  if (status == SharedStatus::Starting) {
+    std::wcerr << L"ScrollGuard is still starting up; try again in a moment." << std::endl;
+    return 4;
+  }
+  if (status == SharedStatus::Incompatible) {
+    std::wcerr << L"The running ScrollGuard is a different version; use its own --heatmap." << std::endl;
+    return 4;
+  }
+  if (status != SharedStatus::Ok || g_shared->header.ownerPid == 0 ||
+      !IsProcessAlive(g_shared->header.ownerPid)) {
+    std::wcerr << L"No running ScrollGuard to read a heatmap from." << std::endl;
+    return 4;
+  }
+  const SessionStats session = g_shared->session; // snapshot; the hook keeps counting
+  const HeatmapStats& heat = session.heat;
+  std::wcout << L"Wheel heatmap from ScrollGuard PID " << g_shared->header.ownerPid
+             << L" (" << kHeatCols << L"x" << kHeatRows << L" cells per monitor)\n"
+             << L"Session: " << session.blocked << L" of " << session.wheelEvents
+             << L" wheel events blocked (counted only while the target is focused)\n";
+  for (DWORD m = 0; m < heat.monitorCount && m < (DWORD)kHeatMaxMonitors; ++m) {
+    const MonitorHeat& mh = heat.monitors[m];
+    unsigned long blockedTotal = 0, passedTotal = 0;
+    unsigned long blockedMax = HottestCell(mh.blocked, blockedTotal);
+    unsigned long passedMax = HottestCell(mh.passed, passedTotal);
+    std::wcout << L"\nMonitor " << mh.displayNumber << (mh.primary ? L" [primary]" : L"")
+               << L"  (" << mh.rect.left << L"," << mh.rect.top
+               << L")-(" << mh.rect.right << L"," << mh.rect.bottom << L")  blocked: "
+               << blockedTotal << L"  passed (target focused): " << passedTotal << L"\n";
+    std::wcout << L"  +" << std::wstring(kHeatCols, L'-') << L"+   +" << std::wstring(kHeatCols, L'-') << L"+\n";
+    for (int r = 0; r < kHeatRows; ++r) {
+      std::wcout << L"  |" << HeatRow(mh.blocked[r], blockedMax) << L"|   |"
+                 << HeatRow(mh.passed[r], passedMax) << L"|\n";
+    }
+    std::wcout << L"  +" << std::wstring(kHeatCols, L'-') << L"+   +" << std::wstring(kHeatCols, L'-') << L"+\n";
+    std::wcout << L"   " << std::left << std::setw(kHeatCols) << L"blocked" << L"     passed (target focused)" << std::right << L"\n";
+  }
+  std::wcout << std::flush;
+  return 0;
+}
+
+typedef NTSTATUS (NTAPI* NtQuerySystemInformationFn)(SYSTEM_INFORMATION_CLASS, PVOID, ULONG, PULONG);
+static const NTSTATUS kStatusInfoLengthMismatch = static_cast<NTSTATUS>(0xC0000004L);
+
+// Context switches of every thread in this process, from the kernel's process
+// snapshot (SYSTEM_THREAD_INFORMATION::Reserved3 is the ContextSwitches count).
+// ntdll is always loaded, so look it up rather than linking ntdll.lib.
+static bool QueryContextSwitches(std::vector<std::pair<DWORD, ULONG>>& threads) {
+  auto query = reinterpret_cast<NtQuerySystemInformationFn>(
+      GetProcAddress(GetModuleHandleW(L"ntdll.dll"), "NtQuerySystemInformation"));
+  if (!query) return false;
+  std::vector<BYTE> buf(256 * 1024);
+  ULONG needed = 0;
+  NTSTATUS status;
+  while ((status = query(SystemProcessInformation, buf.data(), static_cast<ULONG>(buf.size()), &needed)) ==
+         kStatusInfoLengthMismatch) {
+    buf.resize(std::max<size_t>(buf.size() * 2, needed + 64 * 1024)); // processes come and go between calls
+  }
+  if (status < 0) return false;
+
+  const DWORD self = GetCurrentProcessId();
+  for (const BYTE* p = buf.data();;) {
+    const SYSTEM_PROCESS_INFORMATION* proc = reinterpret_cast<const SYSTEM_PROCESS_INFORMATION*>(p);
+    if (HandleToULong(proc->UniqueProcessId) == self) {
+      const SYSTEM_THREAD_INFORMATION* t = reinterpret_cast<const SYSTEM_THREAD_INFORMATION*>(proc + 1);
+      for (ULONG i = 0; i < proc->NumberOfThreads; ++i) {
+        threads.emplace_back(HandleToULong(t[i].ClientId.UniqueThread), t[i].Reserved3);
+      }
+      return true;
+    }
+    if (proc->NextEntryOffset == 0) return false;
+    p += proc->NextEntryOffset;
+  }
+}
+
+// Print what this process cost: wakeups of the hook thread, and context switches
+// for each thread (session totals live in --heatmap)
+static void PrintWakeupStats() {
+  ULONG64 cycles = 0;
+  QueryThreadCycleTime(GetCurrentThread(), &cycles);
+  std::wcout << L"\nStats for this process (hook thread " << g_mainThreadId << L"):\n"
+             << L"  Foreground changes:   " << g_stats.foregroundChanges << L"\n"
+             << L"  Mouse hook wakeups:   " << g_stats.hookCalls
+             << L" (wheel: " << g_stats.wheelEvents << L", blocked: " << g_stats.blocked << L")\n"
+             << L"  Message loop wakeups: " << g_stats.loopWakeups << L"\n"
+             << L"  Hook thread cycles:   " << cycles << L"\n";
+
+  std::vector<std::pair<DWORD, ULONG>> threads;
+  if (!QueryContextSwitches(threads)) {
+    std::wcout << L"  Context switches:     (unavailable)\n";
+    return;
+  }
+  std::wcout << L"  Context switches per thread:\n";
+  for (const auto& t : threads) {
+    std::wcout << L"    " << std::setw(6) << t.first << L": " << t.second
+               << (t.first == g_mainThreadId ? L" (hook thread)" : L"") << L"\n";
+  }
+}
+
+static void FlushInputLine() {
+  // Clear through newline to allow subsequent getline()
+  std::wcin.ignore(std::numeric_limits<std::streamsize>::max(), L'\n');
+}
+
+// List visible apps and let the user pick one (or hover-select fallback); 0 on failure
+static DWORD PickTargetPid() {
   auto apps = EnumerateApps();
 
   if (!apps.empty()) {
@@ -184,20 +652,74 @@ int wmain() {
     }
     std::wcout << L"\nSelection (0 for Hover-Select): ";
     size_t choice = 0;
-    if (!(std::wcin >> choice)) { std::wcerr << L"Invalid input." << std::endl; return 2; }
+    if (!(std::wcin >> choice)) { std::wcerr << L"Invalid input." << std::endl; return 0; }
     FlushInputLine(); // eat trailing newline
 
-    if (choice == 0) {
-      g_targetPid = HoverSelectPid();
-      if (g_targetPid == 0) return 2;
-    } else if (choice >= 1 && choice <= apps.size()) {
-      g_targetPid = apps[choice - 1].pid;
-    } else {
-      std::wcerr << L"Invalid selection." << std::endl; return 2;
+    if (choice == 0) return HoverSelectPid();
+    if (choice <= apps.size()) return apps[choice - 1].pid;
+    std::wcerr << L"Invalid selection." << std::endl;
+    return 0;
+  }
+
+  std::wcout << L"No visible apps found to list. We'll use Hover-Select instead." << std::endl;
+  return HoverSelectPid();
+}
+
+int wmain(int argc, wchar_t** argv) {
+  // Work in physical pixels everywhere: the LL hook reports physical coordinates, so
+  // WindowFromPoint and the monitor rectangles must not be DPI-virtualized
+  SetProcessDpiAwarenessContext(DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2);
+
+  if (argc > 1 && _wcsicmp(argv[1], L"--heatmap") == 0) return PrintHeatmap();
+
+  std::wcout << L"ScrollGuard - block inactive-window scrolling when your chosen app is focused\n";
+  std::wcout << L"--------------------------------------------------------------------------------\n\n";
+
+  const bool upgrade = argc > 1 && _wcsicmp(argv[1], L"--upgrade") == 0;
+
+  // 0) Find out whether another instance is already guarding. If we can't read the
+  //    shared section we can't tell, so refuse rather than hook side by side.
+  DWORD foreignOwner = 0;
+  SharedStatus status = OpenSharedState(true, foreignOwner);
+  if (status == SharedStatus::Starting) {
+    std::wcerr << L"Another ScrollGuard instance is still starting up; try again in a moment." << std::endl;
+    return 4;
+  }
+  if (status == SharedStatus::Incompatible) {
+    std::wcerr << L"A different version of ScrollGuard is running";
+    if (foreignOwner != 0) std::wcerr << L" (PID " << foreignOwner << L")";
+    std::wcerr << L" and can't hand over to this one. Close it first." << std::endl;
+    return 4;
+  }
+  if (status != SharedStatus::Ok) {
+    std::wcerr << L"Could not open ScrollGuard's shared state; another instance may be running"
+               << L" at a different privilege level. Close it first." << std::endl;
+    return 4;
+  }
+  const DWORD prevOwner = LiveOwner();
+
+  if (upgrade) {
+    if (prevOwner == 0 || g_shared->targetPid == 0) {
+      std::wcerr << L"No running ScrollGuard to upgrade from." << std::endl;
+      return 4;
     }
+    // Take over the running instance's policy; session counters continue in place
+    g_targetPid = g_shared->targetPid;
+    std::wcout << L"Upgrading ScrollGuard PID " << prevOwner << L"...\n";
+  } else if (prevOwner != 0) {
+    std::wcerr << L"ScrollGuard is already running (PID " << prevOwner
+               << L"). Start with --upgrade to replace it." << std::endl;
+    return 4;
   } else {
-    std::wcout << L"No visible apps found to list. We'll use Hover-Select instead." << std::endl;
-    g_targetPid = HoverSelectPid();
+    g_shared->targetPid = 0;
+    g_shared->session = SessionStats{};
+  }
+  AttachSession();
+  if (!upgrade) CaptureMonitors(g_session->heat);
+
+  // 1) Enumerate candidates and let the user pick (or hover-select fallback)
+  if (!upgrade) {
+    g_targetPid = PickTargetPid();
     if (g_targetPid == 0) return 2;
   }
 
@@ -206,23 +728,47 @@ int wmain() {
   std::wcout << L"When this app is in the foreground, scrolling over other apps will be blocked." << std::endl;
   std::wcout << L"Press Ctrl+C to quit.\n" << std::endl;
 
-  // 2) Install the low-level mouse hook
+  // 2) Follow the foreground window, and hook the mouse right away if the target has it
   SetConsoleCtrlHandler(ConsoleCtrlHandler, TRUE);
-
-  g_mouseHook = SetWindowsHookExW(WH_MOUSE_LL, LowLevelMouseProc, nullptr, 0);
-  if (!g_mouseHook) {
+  if (!BeginGuarding()) {
     std::wcerr << L"Failed to install mouse hook." << std::endl;
+    EndGuarding();
     return 3;
   }
 
-  // 3) Standard message loop to keep the hook alive
-  MSG msg;
-  while (g_running && GetMessageW(&msg, nullptr, 0, 0) > 0) {
-    TranslateMessage(&msg);
-    DispatchMessageW(&msg);
+  // 3) Publish ownership, then (when upgrading) tell the old instance to unhook.
+  //    Our hook is already live, so there is no moment with nothing guarding.
+  if (!StartHandoffListener()) {
+    std::wcerr << L"Could not start listening for --upgrade handoffs." << std::endl;
+    EndGuarding();
+    return 3;
+  }
+  PublishOwnership();
+  if (prevOwner != 0) {
+    switch (TakeOverFrom(prevOwner, kHandoffTimeoutMs)) {
+    case HandoffResult::Done:
+      std::wcout << L"Hook installed; PID " << prevOwner << L" has unhooked and exited.\n" << std::endl;
+      break;
+    case HandoffResult::Unconfirmed:
+      std::wcerr << L"PID " << prevOwner << L" was told to unhook but hasn't exited within "
+                 << kHandoffTimeoutMs / 1000 << L" s; guarding anyway." << std::endl;
+      break;
+    case HandoffResult::NotSignalled:
+      std::wcerr << L"Handoff failed: PID " << prevOwner
+                 << L" could not be told to unhook and keeps guarding. Close it first." << std::endl;
+      EndGuarding();
+      return 4;
+    }
   }
 
-  if (g_mouseHook) { UnhookWindowsHookEx(g_mouseHook); g_mouseHook = nullptr; }
+  // 4) Sleep in the message loop until Ctrl+C or a handoff posts WM_QUIT
+  RunMessageLoop();
+
+  EndGuarding();
+  ReleaseOwnership();
+  if (g_handedOff) std::wcout << L"\nHanded off to a newer ScrollGuard instance." << std::endl;
+  PrintWakeupStats();
   std::wcout << L"Goodbye." << std::endl;
   return 0;
 }
+#endif // SCROLLGUARD_NO_WMAIN
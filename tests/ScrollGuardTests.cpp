@@ -0,0 +1,489 @@
+// ScrollGuardTests.cpp – runs the real ScrollGuard.cpp core (enumeration, hit
+// testing, hooks, message loop, heatmap, --upgrade handoff) against the simulated
+// desktop in tests/win32_shim.
+//
+// Build & run (Linux/macOS, from the repo root):
+//   g++ -std=c++17 -Wall -Wextra -I tests/win32_shim tests/ScrollGuardTests.cpp -o ScrollGuardTests
+//   ./ScrollGuardTests
+// Exit code is the number of failed checks.
+
+#include <windows.h>
+#include <psapi.h>
+#include <winternl.h>
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <limits>
+
+// The code under test, compiled twice with its own globals each time: guard is the
+// instance most tests drive, peer plays the other process in the handoff tests.
+// Headers are already included above, so only ScrollGuard.cpp's own code repeats.
+// Each copy only uses the parts its role needs.
+#define SCROLLGUARD_NO_WMAIN
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-function"
+namespace guard {
+#include "../ScrollGuard.cpp"
+}
+namespace peer {
+#include "../ScrollGuard.cpp"
+}
+#pragma GCC diagnostic pop
+using namespace guard;
+
+#include <atomic>
+#include <future>
+#include <sstream>
+#include <thread>
+
+static std::atomic<int> g_checks{0};   // some checks run on a simulated hook thread
+static std::atomic<int> g_failures{0};
+
+#define CHECK(cond)                                                          \
+  do {                                                                       \
+    ++g_checks;                                                              \
+    if (!(cond)) {                                                           \
+      ++g_failures;                                                          \
+      std::wcerr << __FILE__ << L":" << __LINE__ << L": CHECK(" #cond ") failed\n"; \
+    }                                                                        \
+  } while (0)
+
+// Fresh globals for one copy of ScrollGuard: RESET_INSTANCE(guard) or RESET_INSTANCE(peer)
+#define RESET_INSTANCE(ns)                  \
+  do {                                      \
+    ns::g_mouseHook = nullptr;              \
+    ns::g_foregroundHook = nullptr;         \
+    ns::g_targetPid = 0;                    \
+    ns::g_stats = ns::WakeupStats{};        \
+    ns::g_localSession = ns::SessionStats{}; \
+    ns::g_session = &ns::g_localSession;    \
+    ns::g_sessionOwner = nullptr;           \
+    ns::g_mainThreadId = 0;                 \
+    ns::g_running = true;                   \
+    ns::g_handedOff = false;                \
+    ns::g_sharedMap = nullptr;              \
+    ns::g_shared = nullptr;                 \
+    ns::g_handoffEvent = nullptr;           \
+  } while (0)
+
+// Fresh desktop and fresh ScrollGuard state
+static void ResetAll() {
+  sim::Reset();
+  RESET_INSTANCE(guard);
+  RESET_INSTANCE(peer);
+}
+
+static RECT Rect(LONG l, LONG t, LONG r, LONG b) { return RECT{l, t, r, b}; }
+
+static void TestEnumerateApps() {
+  ResetAll();
+  sim::Desktop& d = sim::Desk();
+  d.processes[10] = {L"C:\\Games\\arma3_x64.exe"};
+  d.processes[20] = {L"C:\\Program Files\\Discord\\Discord.exe"};
+  d.processes[30] = {L"C:\\Windows\\explorer.exe"};
+  d.processes[40] = {L"C:\\Tools\\locked.exe", false};                       // can't be opened at all
+  d.processes[50] = {L"C:\\Tools\\NoModuleName.exe"};
+  d.processes[50].moduleNameWorks = false;                                   // falls back to QueryFullProcessImageNameW
+  d.processes[60] = {L"C:\\Tools\\Elevated.exe", true, true, false};        // no PROCESS_VM_READ: unknown
+
+  d.Add(20, L"#general - Discord", Rect(1920, 0, 3840, 1080));
+  d.Add(20, L"Discord Updater", Rect(0, 0, 100, 100));                       // same PID: dropped
+  d.Add(10, L"", Rect(0, 0, 1920, 1080));                                    // borderless game, no title
+  d.Add(30, L"hidden", Rect(0, 0, 10, 10), nullptr, false);                  // invisible: skipped
+  d.Add(40, L"Locked", Rect(0, 0, 10, 10));
+  d.Add(50, L"Fallback", Rect(0, 0, 10, 10));
+  d.Add(60, L"Admin", Rect(0, 0, 10, 10));
+
+  std::vector<AppEntry> apps = EnumerateApps();
+  CHECK(apps.size() == 5);
+  if (apps.size() == 5) {
+    // Sorted case-insensitively by process name then title, "(unknown)" first
+    CHECK(apps[0].processName == L"(unknown)" && apps[0].pid == 60);   // "Admin" < "Locked"
+    CHECK(apps[1].processName == L"(unknown)" && apps[1].pid == 40);
+    CHECK(apps[2].processName == L"arma3_x64.exe" && apps[2].windowTitle == L"[No Title]");
+    CHECK(apps[3].processName == L"Discord.exe" && apps[3].windowTitle == L"#general - Discord");
+    CHECK(apps[4].processName == L"NoModuleName.exe" && apps[4].pid == 50);
+  }
+  // One OpenProcess per unique PID
+  CHECK(d.openProcessCalls == 5);
+  CHECK(d.openHandles == 0);
+}
+
+static void TestPidFromPoint() {
+  ResetAll();
+  sim::Desktop& d = sim::Desk();
+  d.Add(10, L"Game", Rect(0, 0, 1920, 1080));
+  HWND chat = d.Add(20, L"Chat", Rect(1920, 0, 3840, 1080));
+  d.Add(99, L"child", Rect(2000, 100, 2200, 300), chat);     // e.g. an embedded control
+  d.Add(30, L"Overlay", Rect(0, 0, 300, 300));               // below Game in z-order
+
+  CHECK(PidFromPoint(POINT{100, 100}) == 10);   // topmost window wins
+  CHECK(PidFromPoint(POINT{2100, 200}) == 20);  // over the child, resolved to chat's root
+  CHECK(PidFromPoint(POINT{3000, 500}) == 20);
+  CHECK(PidFromPoint(POINT{5000, 500}) == 0);   // off every window
+}
+
+static void TestHookFollowsForeground() {
+  ResetAll();
+  sim::Desktop& d = sim::Desk();
+  HWND game = d.Add(10, L"Game", Rect(0, 0, 1920, 1080));
+  HWND chat = d.Add(20, L"Chat", Rect(1920, 0, 3840, 1080));
+  g_targetPid = 10;
+  CHECK(BeginGuarding());
+
+  // Target not foreground: no mouse hook, so movement costs nothing
+  sim::SetForeground(chat);
+  CHECK(!d.MouseHook());
+  CHECK(sim::SendMouse(POINT{2500, 500}) == 0);
+  CHECK(g_stats.hookCalls == 0);
+
+  // Target foreground: hook installed, wheel over other apps is swallowed
+  sim::SetForeground(game);
+  CHECK(d.MouseHook() == LowLevelMouseProc);
+  CHECK(sim::SendMouse(POINT{2500, 500}) != 0);
+  CHECK(sim::SendMouse(POINT{2500, 500}, WM_MOUSEHWHEEL) != 0);
+  CHECK(sim::SendMouse(POINT{500, 500}) == 0);                 // over the target itself
+  CHECK(sim::SendMouse(POINT{2500, 500}, WM_MOUSEMOVE) == 0);  // only wheel events are touched
+  CHECK(sim::SendMouse(POINT{2500, 500}, WM_LBUTTONDOWN) == 0);
+  CHECK(g_stats.hookCalls == 5);
+  CHECK(g_stats.wheelEvents == 3);
+  CHECK(g_stats.blocked == 2);
+
+  // Alt-Tab away: hook removed again
+  sim::SetForeground(chat);
+  CHECK(!d.MouseHook());
+  CHECK(d.hookInstalls == 1 && d.hookRemovals == 1);
+  CHECK(g_stats.foregroundChanges == 3);
+
+  // Hook install failure is reported, not silently ignored
+  d.failHookInstall = true;
+  CHECK(!UpdateMouseHook(game));
+}
+
+static void TestHoverSelectPid() {
+  ResetAll();
+  sim::Desktop& d = sim::Desk();
+  d.Add(10, L"Game", Rect(0, 0, 1920, 1080));
+  d.cursor = POINT{640, 480};
+
+  std::wistringstream in(L"\n");
+  std::wostringstream out, err;
+  std::wstreambuf* oldIn = std::wcin.rdbuf(in.rdbuf());
+  std::wstreambuf* oldOut = std::wcout.rdbuf(out.rdbuf());
+  std::wstreambuf* oldErr = std::wcerr.rdbuf(err.rdbuf());
+  DWORD hit = HoverSelectPid();
+  d.cursor = POINT{5000, 5000};
+  in.clear();
+  in.str(L"\n");
+  DWORD miss = HoverSelectPid();
+  std::wcin.rdbuf(oldIn);
+  std::wcout.rdbuf(oldOut);
+  std::wcerr.rdbuf(oldErr);
+
+  CHECK(hit == 10);
+  CHECK(miss == 0);
+  CHECK(err.str().find(L"Could not resolve") != std::wstring::npos);
+}
+
+static void TestHeatmap() {
+  ResetAll();
+  sim::Desktop& d = sim::Desk();
+  HWND game = d.Add(10, L"Game", Rect(0, 0, 1920, 1080));
+  d.Add(20, L"Chat", Rect(1920, 0, 3840, 1080));
+  g_targetPid = 10;
+  g_session->heat.monitorCount = 2;
+  g_session->heat.monitors[0].rect = Rect(0, 0, 1920, 1080);
+  g_session->heat.monitors[1].rect = Rect(1920, 0, 3840, 1080);
+  CHECK(BeginGuarding());
+  sim::SetForeground(game);
+
+  sim::SendMouse(POINT{1920 + 10, 10});       // blocked, monitor 2 top-left cell
+  sim::SendMouse(POINT{1920 + 10, 10});
+  sim::SendMouse(POINT{3839, 1079});          // blocked, monitor 2 bottom-right cell
+  sim::SendMouse(POINT{960, 540});            // passed, monitor 1 centre
+  sim::SendMouse(POINT{-10, 10});             // blocked, but off every monitor: not in the heatmap
+  CHECK(g_session->heat.monitors[1].blocked[0][0] == 2);
+  CHECK(g_session->heat.monitors[1].blocked[kHeatRows - 1][kHeatCols - 1] == 1);
+  CHECK(g_session->heat.monitors[0].passed[kHeatRows / 2][kHeatCols / 2] == 1);
+  CHECK(g_session->heat.monitors[0].blocked[kHeatRows / 2][kHeatCols / 2] == 0);
+
+  CHECK(g_session->wheelEvents == 5 && g_session->blocked == 4);
+
+  std::wstring row = HeatRow(g_session->heat.monitors[1].blocked[0], 2);
+  CHECK(row.size() == (size_t)kHeatCols);
+  CHECK(row[0] == L'@' && row[1] == L' ');   // the hottest cell is always drawn solid
+
+  unsigned long lone[kHeatCols] = {1};
+  CHECK(HeatRow(lone, 1)[0] == L'@');        // even when it was hit only once
+  unsigned long ramp[kHeatCols] = {1, 5, 9};
+  std::wstring ramped = HeatRow(ramp, 9);
+  CHECK(ramped[0] == L'.' && ramped[2] == L'@' && ramped[1] != L'.' && ramped[1] != L'@');
+  CHECK(HeatRow(g_session->heat.monitors[0].blocked[0], 0) == std::wstring(kHeatCols, L' '));
+}
+
+// After a handoff the old instance keeps its hook for a moment; it must stop
+// writing the shared session counters as soon as the new owner is published
+static void TestOnlyOwnerCountsSession() {
+  ResetAll();
+  sim::Desktop& d = sim::Desk();
+  HWND game = d.Add(10, L"Game", Rect(0, 0, 1920, 1080));
+  d.Add(20, L"Chat", Rect(1920, 0, 3840, 1080));
+  g_targetPid = 10;
+  g_session->heat.monitorCount = 1;
+  g_session->heat.monitors[0].rect = Rect(1920, 0, 3840, 1080);
+  DWORD owner = d.selfPid;
+  g_sessionOwner = &owner;
+  CHECK(BeginGuarding());
+  sim::SetForeground(game);
+
+  CHECK(sim::SendMouse(POINT{2500, 500}) != 0);
+  owner = d.selfPid + 1; // a newer instance took over
+  CHECK(sim::SendMouse(POINT{2500, 500}) != 0); // still guarding until we unhook...
+  CHECK(g_session->blocked == 1);                // ...but no longer counting for the session
+  CHECK(g_session->wheelEvents == 1);
+  CHECK(g_session->heat.monitors[0].blocked[4][4] == 1);      // (580, 500) on a 1920x1080 monitor
+  CHECK(g_stats.blocked == 2);                   // per-process stats still see both
+}
+
+// Run BeginGuarding + RunMessageLoop on their own thread, like wmain does, and
+// hand back the thread once the hooks are in place
+static std::thread StartHookThread() {
+  std::promise<void> hooked;
+  std::future<void> ready = hooked.get_future();
+  std::thread t([&hooked] {
+    CHECK(BeginGuarding());
+    hooked.set_value();
+    RunMessageLoop();
+    EndGuarding();
+  });
+  ready.wait();
+  return t;
+}
+
+// Foreground changes and hook callbacks never surface from GetMessageW, so an
+// idle guard's message loop must not wake at all; only WM_QUIT ends it
+static void TestIdleLoopNeverWakes() {
+  ResetAll();
+  sim::Desktop& d = sim::Desk();
+  HWND game = d.Add(10, L"Game", Rect(0, 0, 1920, 1080));
+  HWND chat = d.Add(20, L"Chat", Rect(1920, 0, 3840, 1080));
+  g_targetPid = 10;
+  d.foreground = chat;
+
+  std::thread hookThread = StartHookThread();
+  CHECK(d.ForegroundHook() == ForegroundEventProc);
+  CHECK(!d.MouseHook());
+  sim::SetForeground(game);
+  CHECK(sim::SendMouse(POINT{2500, 500}) != 0);
+  sim::SendMouse(POINT{2600, 500}, WM_MOUSEMOVE);
+  sim::SetForeground(chat);
+  sim::SendMouse(POINT{2600, 500}, WM_MOUSEMOVE);            // no hook: nothing runs at all
+  PostThreadMessageW(g_mainThreadId, WM_QUIT, 0, 0);
+  hookThread.join();
+
+  CHECK(g_stats.loopWakeups == 0);
+  CHECK(g_stats.foregroundChanges == 2 && g_stats.hookCalls == 2);
+  CHECK(!d.MouseHook() && !d.ForegroundHook());                  // EndGuarding unhooked both
+
+  // Anything that is posted (here a stray timer message) is counted
+  ResetAll();
+  sim::Desk().foreground = chat;
+  g_targetPid = 10;
+  hookThread = StartHookThread();
+  PostThreadMessageW(g_mainThreadId, WM_TIMER, 1, 0);
+  PostThreadMessageW(g_mainThreadId, WM_QUIT, 0, 0);
+  hookThread.join();
+  CHECK(g_stats.loopWakeups == 1);
+}
+
+// The section header is checked before any other field is trusted
+static void TestSharedStateHeader() {
+  ResetAll();
+  DWORD foreign = 0;
+  CHECK(OpenSharedState(false, foreign) == SharedStatus::Missing);
+  CHECK(OpenSharedState(true, foreign) == SharedStatus::Ok);
+  CHECK(g_shared->header.magic == kSharedMagic && g_shared->header.version == kSharedVersion);
+  CHECK(g_shared->header.size == sizeof(SharedState));
+  g_shared->header.ownerPid = 77;
+
+  // Another process sees the same section and its owner
+  CHECK(peer::OpenSharedState(true, foreign) == peer::SharedStatus::Ok);
+  CHECK(peer::g_shared->header.ownerPid == 77 && foreign == 77);
+
+  // A different layout is refused, but the owner is still named
+  g_shared->header.version = kSharedVersion + 1;
+  CHECK(peer::OpenSharedState(false, foreign) == peer::SharedStatus::Incompatible && foreign == 77);
+  g_shared->header.version = kSharedVersion;
+  g_shared->header.size = sizeof(SharedState) - 8;
+  CHECK(peer::OpenSharedState(false, foreign) == peer::SharedStatus::Incompatible && foreign == 77);
+  g_shared->header.size = sizeof(SharedState);
+
+  // Not our section at all: no owner to report
+  g_shared->header.magic = 0x12345678;
+  CHECK(peer::OpenSharedState(false, foreign) == peer::SharedStatus::Incompatible && foreign == 0);
+
+  // Magic 0 is a creator that hasn't finished the header: wait for it...
+  g_shared->header.magic = 0;
+  std::thread creator([] {
+    Sleep(50);
+    InterlockedExchange(&g_shared->header.magic, kSharedMagic);
+  });
+  CHECK(peer::OpenSharedState(false, foreign) == peer::SharedStatus::Ok);
+  creator.join();
+  // ...and report it as starting up, not as another version, if it never does
+  g_shared->header.magic = 0;
+  CHECK(peer::OpenSharedState(false, foreign) == peer::SharedStatus::Starting);
+}
+
+// Without a handoff listener there is nothing for a successor to signal, so the
+// instance must not publish ownership; StartHandoffListener reports it
+static void TestHandoffListenerFailures() {
+  ResetAll();
+  sim::Desktop& d = sim::Desk();
+  d.failCreateEvent = true;
+  CHECK(!StartHandoffListener());
+  d.failCreateEvent = false;
+  d.failCreateThread = true;
+  CHECK(!StartHandoffListener());
+  CHECK(d.openHandles == 0);                          // the event was closed again
+  CHECK(d.events.count(HandoffEventName(d.selfPid)) == 1);
+}
+
+// A successor that can't reach the old instance hands ownership back; one that
+// signals it but never sees it exit says so instead of claiming success
+static void TestTakeOverFailures() {
+  ResetAll();
+  sim::Desktop& d = sim::Desk();
+  d.processes[100] = {L"C:\\ScrollGuard\\v1\\ScrollGuard.exe"};
+  d.processes[200] = {L"C:\\ScrollGuard\\v2\\ScrollGuard.exe"};
+  DWORD foreign = 0;
+  {
+    sim::AsProcess as(100);
+    CHECK(OpenSharedState(true, foreign) == SharedStatus::Ok);
+    g_targetPid = 10;
+    PublishOwnership();                             // ...but no listener (e.g. an older build)
+  }
+  sim::AsProcess as(200);
+  CHECK(peer::OpenSharedState(true, foreign) == peer::SharedStatus::Ok);
+  CHECK(peer::LiveOwner() == 100);
+  peer::g_targetPid = peer::g_shared->targetPid;
+  peer::PublishOwnership();
+  CHECK(peer::TakeOverFrom(100, 1000) == peer::HandoffResult::NotSignalled);
+  CHECK(peer::g_shared->header.ownerPid == 100);  // old instance keeps owning the session
+
+  // Signalled, but the old process never exits
+  HANDLE oldEvent = nullptr;
+  {
+    sim::AsProcess old(100);
+    oldEvent = CreateEventW(nullptr, FALSE, FALSE, HandoffEventName(100).c_str());
+  }
+  peer::PublishOwnership();
+  CHECK(peer::TakeOverFrom(100, 50) == peer::HandoffResult::Unconfirmed);
+  CHECK(WaitForSingleObject(oldEvent, 0) == WAIT_OBJECT_0); // it was told, though
+  CHECK(peer::g_shared->header.ownerPid == 200);
+  CloseHandle(oldEvent);
+}
+
+// --upgrade end to end: the old instance (PID 100) runs its message loop on its own
+// thread while the new one (PID 200, the peer copy) takes over. A third thread
+// scrolls over another app the whole time, and wheel events are also sent between
+// steps; every one of them must be blocked by one of the two hooks.
+static void TestUpgradeHandoffNeverGaps() {
+  ResetAll();
+  sim::Desktop& d = sim::Desk();
+  HWND game = d.Add(10, L"Game", Rect(0, 0, 1920, 1080));
+  d.Add(20, L"Chat", Rect(1920, 0, 3840, 1080));
+  d.processes[100] = {L"C:\\ScrollGuard\\v1\\ScrollGuard.exe"};
+  d.processes[200] = {L"C:\\ScrollGuard\\v2\\ScrollGuard.exe"};
+  d.foreground = game;
+  const POINT overChat{2500, 500};
+  int stepEvents = 0;
+  auto scrollStep = [&] { ++stepEvents; return sim::SendMouse(overChat) != 0; };
+
+  // Old instance, as its wmain would run it
+  std::promise<void> oldHooked;
+  std::future<void> oldReady = oldHooked.get_future();
+  std::thread oldMain([&oldHooked] {
+    sim::AsProcess as(100);
+    DWORD foreign = 0;
+    CHECK(OpenSharedState(true, foreign) == SharedStatus::Ok);
+    CHECK(LiveOwner() == 0);
+    g_targetPid = 10;
+    AttachSession();
+    CHECK(BeginGuarding());
+    CHECK(StartHandoffListener());
+    PublishOwnership();
+    oldHooked.set_value();
+    RunMessageLoop();
+    EndGuarding();
+    ReleaseOwnership();
+    sim::ExitProcess(100);
+  });
+  oldReady.wait();
+  CHECK(scrollStep());                                   // old alone
+
+  std::atomic<bool> swapping{true};
+  std::atomic<int> scrolled{0}, leaked{0};
+  std::thread scroller([&] {
+    while (swapping) {
+      ++scrolled;
+      if (sim::SendMouse(overChat) == 0) ++leaked;
+    }
+  });
+
+  {
+    sim::AsProcess as(200);
+    DWORD foreign = 0;
+    CHECK(peer::OpenSharedState(true, foreign) == peer::SharedStatus::Ok);
+    DWORD prevOwner = peer::LiveOwner();
+    CHECK(prevOwner == 100);
+    peer::g_targetPid = peer::g_shared->targetPid;       // policy comes from the old instance
+    CHECK(peer::g_targetPid == 10);
+    peer::AttachSession();
+    CHECK(peer::BeginGuarding());
+    CHECK(scrollStep());                                 // both hooked, old still owns
+    CHECK(peer::StartHandoffListener());
+    peer::PublishOwnership();
+    CHECK(scrollStep());                                 // new owns, old still hooked
+    CHECK(peer::TakeOverFrom(prevOwner, 5000) == peer::HandoffResult::Done);
+  }
+  oldMain.join();
+  CHECK(scrollStep());                                   // new alone
+  swapping = false;
+  scroller.join();
+
+  CHECK(scrolled > 0);
+  CHECK(leaked == 0);
+  CHECK(g_handedOff);                                    // old quit because it was told to
+  CHECK(d.mouseHooks.size() == 1 && d.mouseHooks[0].pid == 200);
+  CHECK(peer::g_shared->header.ownerPid == 200);         // old's ReleaseOwnership left it alone
+  // The first hook to block an event ends the chain, so each was blocked exactly once
+  CHECK(g_stats.blocked + peer::g_stats.blocked == static_cast<unsigned long long>(scrolled + stepEvents));
+  // The session is written by whichever instance owns it at the time: never twice
+  CHECK(peer::g_shared->session.blocked <= static_cast<unsigned long long>(scrolled + stepEvents));
+  CHECK(peer::g_shared->session.blocked == peer::g_shared->session.wheelEvents);
+
+  sim::AsProcess as(200);
+  peer::EndGuarding();
+  peer::ReleaseOwnership();
+  CHECK(peer::g_shared->header.ownerPid == 0);
+}
+
+int main() {
+  TestEnumerateApps();
+  TestPidFromPoint();
+  TestHookFollowsForeground();
+  TestHoverSelectPid();
+  TestHeatmap();
+  TestOnlyOwnerCountsSession();
+  TestIdleLoopNeverWakes();
+  TestSharedStateHeader();
+  TestHandoffListenerFailures();
+  TestTakeOverFailures();
+  TestUpgradeHandoffNeverGaps();
+  std::wcout << g_checks.load() << L" checks, " << g_failures.load() << L" failed" << std::endl;
+  return g_failures.load();
+}
@@ -0,0 +1,18 @@
+// psapi.h (test shim) – GetModuleBaseNameW on top of the simulated desktop in windows.h
+
+#pragma once
+
+#include "windows.h"
+
+// Base name of the process image (needs PROCESS_VM_READ on the real system)
+inline DWORD GetModuleBaseNameW(HANDLE h, HANDLE, wchar_t* buf, DWORD size) {
+  const sim::ProcessHandle& ph = *sim::As<sim::ProcessHandle>(h);
+  const sim::Process& p = sim::Desk().processes[ph.pid];
+  if (!(ph.access & PROCESS_VM_READ) || !p.moduleNameWorks) return 0;
+  const std::wstring& path = p.imagePath;
+  size_t slash = path.find_last_of(L"\\/");
+  std::wstring base = (slash == std::wstring::npos) ? path : path.substr(slash + 1);
+  if (base.empty() || base.size() + 1 > size) return 0;
+  wcscpy(buf, base.c_str());
+  return static_cast<DWORD>(base.size());
+}
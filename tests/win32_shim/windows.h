@@ -0,0 +1,602 @@
+// windows.h (test shim) – the subset of user32/kernel32 that ScrollGuard.cpp's
+// core uses, implemented on top of a simulated desktop so the real code can be
+// compiled and exercised on Linux.
+//
+// The desktop is a list of windows (siblings in z-order, topmost first) plus a table of
+// processes. Tests build it through sim::Desk(), then inject input with
+// sim::SendMouse() / sim::SetForeground(), which invoke whatever hooks the code
+// under test has installed, just like the real system would.
+//
+// Hook callbacks run on the thread that injects the input, as the process that
+// installed them (see sim::AsProcess). Everything another thread can block on is
+// real, though: GetMessageW waits for a posted message, WaitForSingleObject for an
+// event or a process exit, and CreateThread starts a std::thread. So a test can run
+// two instances' message loops side by side and hand off between them.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cwchar>
+#include <cwctype>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef uint32_t DWORD;
+typedef int BOOL;
+typedef int32_t LONG;
+typedef unsigned int UINT;
+typedef unsigned long long ULONG64;
+typedef size_t SIZE_T;
+typedef intptr_t LPARAM;
+typedef uintptr_t WPARAM;
+typedef intptr_t LRESULT;
+typedef void* LPVOID;
+typedef void* HANDLE;
+typedef struct HWND__* HWND;
+typedef struct HHOOK__* HHOOK;
+typedef struct HWINEVENTHOOK__* HWINEVENTHOOK;
+typedef struct HINSTANCE__* HINSTANCE;
+
+#define CALLBACK
+#define WINAPI
+#define TRUE 1
+#define FALSE 0
+#define MAX_PATH 260
+#define INFINITE 0xFFFFFFFFu
+#define INVALID_HANDLE_VALUE (reinterpret_cast<HANDLE>(static_cast<intptr_t>(-1)))
+
+struct POINT { LONG x, y; };
+struct RECT { LONG left, top, right, bottom; };
+struct MSLLHOOKSTRUCT { POINT pt; DWORD mouseData; DWORD flags; DWORD time; uintptr_t dwExtraInfo; };
+struct MSG { HWND hwnd; UINT message; WPARAM wParam; LPARAM lParam; DWORD time; POINT pt; };
+struct MEMORY_BASIC_INFORMATION { LPVOID BaseAddress; LPVOID AllocationBase; DWORD AllocationProtect; SIZE_T RegionSize; DWORD State; DWORD Protect; DWORD Type; };
+
+#define HC_ACTION 0
+#define WM_QUIT 0x0012
+#define WM_TIMER 0x0113
+#define WH_MOUSE_LL 14
+#define WM_MOUSEMOVE 0x0200
+#define WM_LBUTTONDOWN 0x0201
+#define WM_MOUSEWHEEL 0x020A
+#define WM_MOUSEHWHEEL 0x020E
+#define GA_ROOT 2
+#define EVENT_SYSTEM_FOREGROUND 0x0003
+#define WINEVENT_OUTOFCONTEXT 0x0000
+#define WINEVENT_SKIPOWNPROCESS 0x0002
+#define PROCESS_VM_READ 0x0010
+#define PROCESS_QUERY_LIMITED_INFORMATION 0x1000
+#define SYNCHRONIZE 0x00100000
+#define EVENT_MODIFY_STATE 0x0002
+#define PAGE_READWRITE 0x04
+#define FILE_MAP_ALL_ACCESS 0x000F001F
+#define WAIT_OBJECT_0 0u
+#define WAIT_TIMEOUT 258u
+#define ERROR_FILE_NOT_FOUND 2
+#define ERROR_NOT_ENOUGH_MEMORY 8
+#define ERROR_ALREADY_EXISTS 183
+
+typedef LRESULT (CALLBACK* HOOKPROC)(int, WPARAM, LPARAM);
+typedef void (CALLBACK* WINEVENTPROC)(HWINEVENTHOOK, DWORD, HWND, LONG, LONG, DWORD, DWORD);
+typedef BOOL (CALLBACK* WNDENUMPROC)(HWND, LPARAM);
+typedef DWORD (WINAPI* LPTHREAD_START_ROUTINE)(LPVOID);
+
+namespace sim {
+
+struct Window {
+  HWND parent = nullptr;  // nullptr for top-level windows
+  DWORD pid = 0;
+  std::wstring title;
+  bool visible = true;
+  RECT rect{};            // screen coordinates, used by WindowFromPoint
+};
+
+struct Process {
+  std::wstring imagePath;         // what QueryFullProcessImageNameW reports
+  bool openable = true;           // OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION) succeeds
+  bool imageQueryWorks = true;    // QueryFullProcessImageNameW succeeds
+  bool vmReadable = true;         // OpenProcess(... | PROCESS_VM_READ) succeeds
+  bool moduleNameWorks = true;    // GetModuleBaseNameW succeeds (fails e.g. for 32/64-bit mismatches)
+  bool exited = false;            // set by sim::ExitProcess; signals its process handles
+};
+
+struct LowLevelHook { HOOKPROC proc; DWORD pid; HHOOK id; };
+struct WinEventHook { WINEVENTPROC proc; DWORD pid; HWINEVENTHOOK id; };
+
+// Kernel objects behind HANDLEs
+struct Object { virtual ~Object() = default; };
+struct ProcessHandle : Object {
+  DWORD pid, access;
+  ProcessHandle(DWORD p, DWORD a) : pid(p), access(a) {}
+};
+struct Event { bool signaled = false; bool manualReset = false; };
+struct EventHandle : Object {
+  std::shared_ptr<Event> event;
+  explicit EventHandle(std::shared_ptr<Event> e) : event(std::move(e)) {}
+};
+struct Section { std::vector<unsigned char> bytes; };  // a whole number of pages, zero-filled
+struct SectionHandle : Object {
+  std::shared_ptr<Section> section;
+  explicit SectionHandle(std::shared_ptr<Section> s) : section(std::move(s)) {}
+};
+struct ThreadHandle : Object {};
+
+struct Desktop {
+  std::vector<Window> windows;    // z-order among siblings, topmost first; HWND == index + 1
+  std::map<DWORD, Process> processes;
+  DWORD selfPid = 4242;           // what GetCurrentProcessId reports outside sim::AsProcess
+  HWND foreground = nullptr;
+  POINT cursor{};
+  bool failHookInstall = false;
+  bool failCreateEvent = false;
+  bool failCreateThread = false;
+
+  std::vector<LowLevelHook> mouseHooks;       // newest first, like the real hook chain
+  std::vector<WinEventHook> foregroundHooks;
+  uintptr_t nextHookId = 1;
+
+  std::map<std::wstring, std::shared_ptr<Section>> sections;  // named file mappings
+  std::map<std::wstring, std::shared_ptr<Event>> events;      // named events
+  std::map<DWORD, std::deque<MSG>> queues;                    // posted messages by thread id
+
+  // Call accounting so tests can check what the code asked the system for
+  int openProcessCalls = 0;
+  int openHandles = 0;
+  int hookInstalls = 0;
+  int hookRemovals = 0;
+
+  HWND Add(DWORD pid, const std::wstring& title, RECT rect, HWND parent = nullptr, bool visible = true) {
+    Window w;
+    w.parent = parent;
+    w.pid = pid;
+    w.title = title;
+    w.visible = visible;
+    w.rect = rect;
+    windows.push_back(w);
+    return reinterpret_cast<HWND>(static_cast<uintptr_t>(windows.size()));
+  }
+
+  Window* Find(HWND h) {
+    uintptr_t i = reinterpret_cast<uintptr_t>(h);
+    return (i >= 1 && i <= windows.size()) ? &windows[i - 1] : nullptr;
+  }
+
+  // The hooks that run first, or nullptr when none is installed
+  HOOKPROC MouseHook() const { return mouseHooks.empty() ? nullptr : mouseHooks.front().proc; }
+  WINEVENTPROC ForegroundHook() const { return foregroundHooks.empty() ? nullptr : foregroundHooks.front().proc; }
+};
+
+inline Desktop& Desk() {
+  static Desktop d;
+  return d;
+}
+
+// Guards every Desktop member another thread may touch while a test runs two
+// instances at once (hooks, kernel objects, queues, counters); the window list is
+// only changed while no other thread is running. Never freed, so threads still
+// blocked at exit don't wait on a destroyed condition variable.
+struct Sync {
+  std::mutex lock;
+  std::condition_variable changed;  // anything a waiter could be waiting for
+  std::mutex input;                 // input is delivered one event at a time, as on Windows
+};
+
+inline Sync& Kernel() {
+  static Sync* s = new Sync;
+  return *s;
+}
+
+typedef std::unique_lock<std::mutex> Hold;
+
+// Start over with an empty desktop (hooks the code under test installed are dropped too)
+inline void Reset() {
+  Hold hold(Kernel().lock);
+  Desk() = Desktop{};
+}
+
+// Which process the calling thread belongs to; 0 means Desk().selfPid
+inline DWORD& ThreadPid() {
+  thread_local DWORD pid = 0;
+  return pid;
+}
+
+// Run the calling thread as process pid for the lifetime of the object, so two
+// copies of the code under test can live in one test binary as two "processes"
+struct AsProcess {
+  DWORD saved;
+  explicit AsProcess(DWORD pid) : saved(ThreadPid()) { ThreadPid() = pid; }
+  ~AsProcess() { ThreadPid() = saved; }
+};
+
+inline DWORD& LastError() {
+  thread_local DWORD error = 0;
+  return error;
+}
+
+// Hand out a HANDLE for a kernel object (CloseHandle deletes it again).
+// The caller holds Kernel().lock.
+inline HANDLE NewHandle(Object* obj) {
+  ++Desk().openHandles;
+  return static_cast<HANDLE>(obj);
+}
+
+template <typename T> T* As(HANDLE h) { return dynamic_cast<T*>(static_cast<Object*>(h)); }
+
+// End a simulated process: whoever waits on one of its handles wakes up
+inline void ExitProcess(DWORD pid) {
+  {
+    Hold hold(Kernel().lock);
+    Desk().processes[pid].exited = true;
+  }
+  Kernel().changed.notify_all();
+}
+
+// Deliver a mouse message through the low-level hook chain, newest hook first, each
+// running as the process that installed it. A hook that returns non-zero swallows
+// the event and the rest of the chain never sees it, as with the real
+// CallNextHookEx. Returns non-zero if the event was swallowed.
+inline LRESULT SendMouse(POINT pt, WPARAM msg = WM_MOUSEWHEEL) {
+  Hold serial(Kernel().input);
+  std::vector<LowLevelHook> chain;
+  {
+    Hold hold(Kernel().lock);
+    Desk().cursor = pt;
+    chain = Desk().mouseHooks;
+  }
+  MSLLHOOKSTRUCT info{};
+  info.pt = pt;
+  for (const LowLevelHook& hook : chain) {
+    AsProcess as(hook.pid);
+    if (LRESULT r = hook.proc(HC_ACTION, msg, reinterpret_cast<LPARAM>(&info))) return r;
+  }
+  return 0;
+}
+
+// Change the foreground window and raise EVENT_SYSTEM_FOREGROUND
+inline void SetForeground(HWND h) {
+  Hold serial(Kernel().input);
+  std::vector<WinEventHook> hooks;
+  {
+    Hold hold(Kernel().lock);
+    Desk().foreground = h;
+    hooks = Desk().foregroundHooks;
+  }
+  for (const WinEventHook& hook : hooks) {
+    AsProcess as(hook.pid);
+    hook.proc(hook.id, EVENT_SYSTEM_FOREGROUND, h, 0, 0, 0, 0);
+  }
+}
+
+} // namespace sim
+
+// ---- kernel32 ----
+
+inline DWORD GetLastError() { return sim::LastError(); }
+inline void SetLastError(DWORD error) { sim::LastError() = error; }
+
+inline DWORD GetCurrentProcessId() {
+  DWORD pid = sim::ThreadPid();
+  return pid ? pid : sim::Desk().selfPid;
+}
+
+inline DWORD GetCurrentThreadId() {
+  static std::atomic<DWORD> next{1000};
+  thread_local DWORD id = next++;
+  return id;
+}
+
+inline HANDLE OpenProcess(DWORD access, BOOL, DWORD pid) {
+  sim::Hold hold(sim::Kernel().lock);
+  sim::Desktop& d = sim::Desk();
+  ++d.openProcessCalls;
+  auto it = d.processes.find(pid);
+  if (it == d.processes.end() || !it->second.openable || it->second.exited) return nullptr;
+  if ((access & PROCESS_VM_READ) && !it->second.vmReadable) return nullptr;
+  return sim::NewHandle(new sim::ProcessHandle(pid, access));
+}
+
+inline BOOL CloseHandle(HANDLE h) {
+  if (!h) return FALSE;
+  sim::Hold hold(sim::Kernel().lock);
+  --sim::Desk().openHandles;
+  delete static_cast<sim::Object*>(h);
+  return TRUE;
+}
+
+inline BOOL QueryFullProcessImageNameW(HANDLE h, DWORD, wchar_t* buf, DWORD* size) {
+  const sim::Process& p = sim::Desk().processes[sim::As<sim::ProcessHandle>(h)->pid];
+  if (!p.imageQueryWorks || p.imagePath.size() + 1 > *size) return FALSE;
+  wcscpy(buf, p.imagePath.c_str());
+  *size = static_cast<DWORD>(p.imagePath.size());
+  return TRUE;
+}
+
+inline int _wcsicmp(const wchar_t* a, const wchar_t* b) {
+  for (;; ++a, ++b) {
+    wint_t ca = towlower(static_cast<wint_t>(*a)), cb = towlower(static_cast<wint_t>(*b));
+    if (ca != cb) return ca < cb ? -1 : 1;
+    if (ca == 0) return 0;
+  }
+}
+
+inline void Sleep(DWORD ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+
+inline LONG InterlockedExchange(volatile LONG* target, LONG value) {
+  return __atomic_exchange_n(target, value, __ATOMIC_SEQ_CST);
+}
+
+inline LONG InterlockedCompareExchange(volatile LONG* target, LONG exchange, LONG comparand) {
+  __atomic_compare_exchange_n(target, &comparand, exchange, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+  return comparand; // the initial value either way
+}
+
+inline void MemoryBarrier() { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+
+// Pagefile-backed sections only; sizes round up to whole pages like the real thing
+inline HANDLE CreateFileMappingW(HANDLE, void*, DWORD, DWORD, DWORD size, const wchar_t* name) {
+  sim::Hold hold(sim::Kernel().lock);
+  std::shared_ptr<sim::Section>& section = sim::Desk().sections[name];
+  if (section) {
+    SetLastError(ERROR_ALREADY_EXISTS);
+  } else {
+    section = std::make_shared<sim::Section>();
+    section->bytes.resize((size + 4095) / 4096 * 4096);
+    SetLastError(0);
+  }
+  return sim::NewHandle(new sim::SectionHandle(section));
+}
+
+inline HANDLE OpenFileMappingW(DWORD, BOOL, const wchar_t* name) {
+  sim::Hold hold(sim::Kernel().lock);
+  auto it = sim::Desk().sections.find(name);
+  if (it == sim::Desk().sections.end()) {
+    SetLastError(ERROR_FILE_NOT_FOUND);
+    return nullptr;
+  }
+  return sim::NewHandle(new sim::SectionHandle(it->second));
+}
+
+// Every view of a section is the same memory, so two "processes" really share it
+inline LPVOID MapViewOfFile(HANDLE h, DWORD, DWORD, DWORD, SIZE_T size) {
+  sim::Section& section = *sim::As<sim::SectionHandle>(h)->section;
+  if (size > section.bytes.size()) {
+    SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+    return nullptr;
+  }
+  return section.bytes.data();
+}
+
+inline BOOL UnmapViewOfFile(const void*) { return TRUE; }
+
+inline SIZE_T VirtualQuery(const void* addr, MEMORY_BASIC_INFORMATION* info, SIZE_T) {
+  sim::Hold hold(sim::Kernel().lock);
+  const unsigned char* p = static_cast<const unsigned char*>(addr);
+  for (const auto& named : sim::Desk().sections) {
+    const std::vector<unsigned char>& bytes = named.second->bytes;
+    if (p < bytes.data() || p >= bytes.data() + bytes.size()) continue;
+    *info = MEMORY_BASIC_INFORMATION{};
+    info->BaseAddress = const_cast<unsigned char*>(p);
+    info->RegionSize = static_cast<SIZE_T>(bytes.data() + bytes.size() - p);
+    return sizeof(*info);
+  }
+  return 0;
+}
+
+inline HANDLE CreateEventW(void*, BOOL manualReset, BOOL initialState, const wchar_t* name) {
+  sim::Hold hold(sim::Kernel().lock);
+  sim::Desktop& d = sim::Desk();
+  if (d.failCreateEvent) return nullptr;
+  std::shared_ptr<sim::Event> event;
+  if (name && d.events.count(name)) {
+    event = d.events[name];
+    SetLastError(ERROR_ALREADY_EXISTS);
+  } else {
+    event = std::make_shared<sim::Event>();
+    event->signaled = initialState != FALSE;
+    event->manualReset = manualReset != FALSE;
+    if (name) d.events[name] = event;
+    SetLastError(0);
+  }
+  return sim::NewHandle(new sim::EventHandle(event));
+}
+
+inline HANDLE OpenEventW(DWORD, BOOL, const wchar_t* name) {
+  sim::Hold hold(sim::Kernel().lock);
+  auto it = sim::Desk().events.find(name);
+  if (it == sim::Desk().events.end()) {
+    SetLastError(ERROR_FILE_NOT_FOUND);
+    return nullptr;
+  }
+  return sim::NewHandle(new sim::EventHandle(it->second));
+}
+
+inline BOOL SetEvent(HANDLE h) {
+  sim::EventHandle* eh = sim::As<sim::EventHandle>(h);
+  if (!eh) return FALSE;
+  {
+    sim::Hold hold(sim::Kernel().lock);
+    eh->event->signaled = true;
+  }
+  sim::Kernel().changed.notify_all();
+  return TRUE;
+}
+
+// Events (a successful wait resets auto-reset ones) and process handles
+inline DWORD WaitForSingleObject(HANDLE h, DWORD ms) {
+  sim::Hold hold(sim::Kernel().lock);
+  sim::EventHandle* eh = sim::As<sim::EventHandle>(h);
+  sim::ProcessHandle* ph = sim::As<sim::ProcessHandle>(h);
+  auto ready = [&] { return eh ? eh->event->signaled : ph && sim::Desk().processes[ph->pid].exited; };
+  if (ms == INFINITE) {
+    sim::Kernel().changed.wait(hold, ready);
+  } else if (!sim::Kernel().changed.wait_for(hold, std::chrono::milliseconds(ms), ready)) {
+    return WAIT_TIMEOUT;
+  }
+  if (eh && !eh->event->manualReset) eh->event->signaled = false;
+  return WAIT_OBJECT_0;
+}
+
+// A real thread, belonging to the same simulated process as its creator
+inline HANDLE CreateThread(void*, SIZE_T, LPTHREAD_START_ROUTINE proc, LPVOID param, DWORD, DWORD* threadId) {
+  sim::Hold hold(sim::Kernel().lock);
+  if (sim::Desk().failCreateThread) return nullptr;
+  DWORD pid = GetCurrentProcessId();
+  std::thread([proc, param, pid] {
+    sim::AsProcess as(pid);
+    proc(param);
+  }).detach();
+  if (threadId) *threadId = 0;
+  return sim::NewHandle(new sim::ThreadHandle);
+}
+
+// ---- user32 ----
+
+inline BOOL EnumWindows(WNDENUMPROC proc, LPARAM lParam) {
+  sim::Desktop& d = sim::Desk();
+  for (size_t i = 0; i < d.windows.size(); ++i) {
+    if (d.windows[i].parent) continue; // top-level only
+    if (!proc(reinterpret_cast<HWND>(static_cast<uintptr_t>(i + 1)), lParam)) break;
+  }
+  return TRUE;
+}
+
+inline BOOL IsWindowVisible(HWND h) {
+  sim::Window* w = sim::Desk().Find(h);
+  return w && w->visible;
+}
+
+inline DWORD GetWindowThreadProcessId(HWND h, DWORD* pid) {
+  sim::Window* w = sim::Desk().Find(h);
+  if (pid) *pid = w ? w->pid : 0;
+  return w ? 1 : 0;
+}
+
+inline int GetWindowTextLengthW(HWND h) {
+  sim::Window* w = sim::Desk().Find(h);
+  return w ? static_cast<int>(w->title.size()) : 0;
+}
+
+inline int GetWindowTextW(HWND h, wchar_t* buf, int maxCount) {
+  sim::Window* w = sim::Desk().Find(h);
+  if (!w || maxCount <= 0) return 0;
+  size_t n = std::min(w->title.size(), static_cast<size_t>(maxCount - 1));
+  wmemcpy(buf, w->title.data(), n);
+  buf[n] = L'\0';
+  return static_cast<int>(n);
+}
+
+// Topmost visible top-level window under pt, then the deepest visible child under pt
+inline HWND WindowFromPoint(POINT pt) {
+  sim::Desktop& d = sim::Desk();
+  auto hit = [&](size_t i) {
+    const sim::Window& w = d.windows[i];
+    return w.visible && pt.x >= w.rect.left && pt.x < w.rect.right && pt.y >= w.rect.top && pt.y < w.rect.bottom;
+  };
+  HWND found = nullptr;
+  for (bool descended = true; descended;) {
+    descended = false;
+    for (size_t i = 0; i < d.windows.size(); ++i) {
+      if (d.windows[i].parent != found || !hit(i)) continue;
+      found = reinterpret_cast<HWND>(static_cast<uintptr_t>(i + 1));
+      descended = true;
+      break;
+    }
+  }
+  return found;
+}
+
+inline HWND GetAncestor(HWND h, UINT) {
+  sim::Window* w = sim::Desk().Find(h);
+  if (!w) return nullptr;
+  while (w->parent) {
+    h = w->parent;
+    w = sim::Desk().Find(h);
+  }
+  return h;
+}
+
+inline HWND GetForegroundWindow() { return sim::Desk().foreground; }
+
+inline BOOL GetCursorPos(POINT* pt) {
+  sim::Hold hold(sim::Kernel().lock);
+  *pt = sim::Desk().cursor;
+  return TRUE;
+}
+
+// Goes to the head of the chain. Fails if the calling process already has a hook,
+// which the code under test should never ask for.
+inline HHOOK SetWindowsHookExW(int, HOOKPROC proc, HINSTANCE, DWORD) {
+  sim::Hold hold(sim::Kernel().lock);
+  sim::Desktop& d = sim::Desk();
+  DWORD pid = GetCurrentProcessId();
+  bool hooked = std::any_of(d.mouseHooks.begin(), d.mouseHooks.end(),
+                            [pid](const sim::LowLevelHook& h) { return h.pid == pid; });
+  if (d.failHookInstall || hooked) return nullptr;
+  ++d.hookInstalls;
+  HHOOK id = reinterpret_cast<HHOOK>(d.nextHookId++);
+  d.mouseHooks.insert(d.mouseHooks.begin(), sim::LowLevelHook{proc, pid, id});
+  return id;
+}
+
+inline BOOL UnhookWindowsHookEx(HHOOK id) {
+  sim::Hold hold(sim::Kernel().lock);
+  sim::Desktop& d = sim::Desk();
+  auto it = std::find_if(d.mouseHooks.begin(), d.mouseHooks.end(),
+                         [id](const sim::LowLevelHook& h) { return h.id == id; });
+  if (it == d.mouseHooks.end()) return FALSE;
+  ++d.hookRemovals;
+  d.mouseHooks.erase(it);
+  return TRUE;
+}
+
+inline LRESULT CallNextHookEx(HHOOK, int, WPARAM, LPARAM) { return 0; } // sim::SendMouse walks the chain
+
+inline HWINEVENTHOOK SetWinEventHook(DWORD, DWORD, HINSTANCE, WINEVENTPROC proc, DWORD, DWORD, DWORD) {
+  sim::Hold hold(sim::Kernel().lock);
+  sim::Desktop& d = sim::Desk();
+  HWINEVENTHOOK id = reinterpret_cast<HWINEVENTHOOK>(d.nextHookId++);
+  d.foregroundHooks.insert(d.foregroundHooks.begin(), sim::WinEventHook{proc, GetCurrentProcessId(), id});
+  return id;
+}
+
+inline BOOL UnhookWinEvent(HWINEVENTHOOK id) {
+  sim::Hold hold(sim::Kernel().lock);
+  sim::Desktop& d = sim::Desk();
+  auto it = std::find_if(d.foregroundHooks.begin(), d.foregroundHooks.end(),
+                         [id](const sim::WinEventHook& h) { return h.id == id; });
+  if (it == d.foregroundHooks.end()) return FALSE;
+  d.foregroundHooks.erase(it);
+  return TRUE;
+}
+
+inline BOOL PostThreadMessageW(DWORD threadId, UINT msg, WPARAM wParam, LPARAM lParam) {
+  if (threadId == 0) return FALSE;
+  {
+    sim::Hold hold(sim::Kernel().lock);
+    sim::Desk().queues[threadId].push_back(MSG{nullptr, msg, wParam, lParam, 0, POINT{}});
+  }
+  sim::Kernel().changed.notify_all();
+  return TRUE;
+}
+
+// Blocks until something is posted to the calling thread; 0 for WM_QUIT
+inline BOOL GetMessageW(MSG* msg, HWND, UINT, UINT) {
+  sim::Hold hold(sim::Kernel().lock);
+  DWORD self = GetCurrentThreadId();
+  sim::Kernel().changed.wait(hold, [self] { return !sim::Desk().queues[self].empty(); });
+  std::deque<MSG>& mine = sim::Desk().queues[self];
+  *msg = mine.front();
+  mine.pop_front();
+  return msg->message != WM_QUIT;
+}
+
+inline BOOL TranslateMessage(const MSG*) { return FALSE; }
+inline LRESULT DispatchMessageW(const MSG*) { return 0; }
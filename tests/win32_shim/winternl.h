@@ -0,0 +1,6 @@
+// winternl.h (test shim) – only the console front end's exit stats use the NT
+// types from here, and that code is compiled out of the tests
+
+#pragma once
+
+#include "windows.h"